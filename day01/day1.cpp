@@ -1,10 +1,92 @@
 #include <algorithm>
+#include <array>
+#include <cstddef>
 #include <functional>
 #include <fstream>
 #include <iostream>
-#include <string>
+#include <numeric>
+#include <queue>
 #include <vector>
 
+namespace {
+    constexpr std::size_t top_elves = 3U;
+}
+
+// Keeps the k largest values seen so far in a min-heap, so each new value is compared with the
+// smallest kept one and only replaces it when larger.
+template<typename T>
+class Top_K {
+public:
+    explicit Top_K(std::size_t k) : m_k(k) {}
+
+    void push(T value) {
+        if (m_heap.size() < m_k) {
+            m_heap.push(value);
+        } else if (m_k > 0 && m_heap.top() < value) {
+            m_heap.pop();
+            m_heap.push(value);
+        }
+    }
+
+    /* The kept values, largest first. */
+    std::vector<T> sorted() const {
+        auto heap = m_heap;
+        std::vector<T> values;
+        for (; !heap.empty(); heap.pop()) {
+            values.push_back(heap.top());
+        }
+        std::reverse(values.begin(), values.end());
+        return values;
+    }
+
+private:
+    std::size_t m_k;
+    std::priority_queue<T, std::vector<T>, std::greater<T>> m_heap;
+};
+
+// Reads the calorie list in blocks and calls on_group with the total of every group of lines,
+// groups being separated by blank lines.
+template<typename F>
+void for_each_group_total(std::istream& is, F on_group) {
+    constexpr std::size_t block_size = 1 << 16;
+    std::array<char, block_size> block;
+    long long total = 0;
+    long long value = 0;
+    bool in_group = false;
+    bool line_empty = true;
+    while (is) {
+        is.read(block.data(), block_size);
+        const auto n = static_cast<std::size_t>(is.gcount());
+        for (std::size_t i = 0; i < n; ++i) {
+            const char c = block[i];
+            if ('0' <= c && c <= '9') {
+                value = value * 10 + (c - '0');
+                line_empty = false;
+            } else if (c == '\n') {
+                if (line_empty) {
+                    if (in_group) {
+                        on_group(total);
+                    }
+                    total = 0;
+                    in_group = false;
+                } else {
+                    total += value;
+                    in_group = true;
+                }
+                value = 0;
+                line_empty = true;
+            }
+        }
+    }
+    if (!line_empty) {
+        total += value;
+        in_group = true;
+    }
+    if (in_group) {
+        on_group(total);
+    }
+}
+
 int main() {
     for (auto file : {"sample.txt", "input.txt"}) {
         std::ifstream input {file};
@@ -12,18 +94,12 @@ int main() {
             std::cerr << "Failed to open: " << file << '\n';
             return 1;
         }
-        std::vector<int> data = {0};
-        std::string line;
-        while (std::getline(input, line)) {
-            if (line.empty())
-                data.push_back(0);
-            else
-                data.back() += std::stoi(line);
-        }
-        std::sort(data.begin(), data.end(), std::greater<int>{});
+        Top_K<long long> top {top_elves};
+        for_each_group_total(input, [&top](long long total) { top.push(total); });
+        const auto data = top.sorted();
         std::cout << file << ":\n";
         std::cout << "Answer part 1:  " << data[0] << '\n';
-        std::cout << "Answer part 2:  " << data[0] + data[1] + data[2] << '\n';
+        std::cout << "Answer part 2:  " << std::accumulate(data.begin(), data.end(), 0LL) << '\n';
     }
     return 0;
 }
@@ -1,48 +1,164 @@
 #include <algorithm>
-#include <fstream>
+#include <cstdint>
 #include <iostream>
-#include <map>
-#include <set>
-#include <string>
+#include <numeric>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    constexpr unsigned int group_size = 3U;
+}
+
+// Item sets as bitmasks with bit p set for an item of priority p (1-52).
+std::uint64_t item_mask(std::string_view items) {
+    std::uint64_t mask = 0;
+    for (char item : items) {
+        mask |= std::uint64_t{1} << (item >= 'a' ? item - 'a' + 1 : item - 'A' + 27);
+    }
+    return mask;
+}
+
+/* Priority of the lowest item in the mask, 0 if it is empty. */
+int priority(std::uint64_t mask) {
+    return mask ? __builtin_ctzll(mask) : 0;
+}
+
+struct Scores {
+    long long one = 0;
+    long long two = 0;
+};
+
+/* Scores whole lines of text, which must start at a group boundary. */
+Scores score_lines(std::string_view text, unsigned int group_size) {
+    Scores scores;
+    unsigned int in_group = 0;
+    std::uint64_t group = ~std::uint64_t{0};
+    while (!text.empty()) {
+        const std::size_t newline = text.find('\n');
+        const std::string_view rucksack = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+
+        const std::size_t half_len = rucksack.length() / 2;
+        scores.one += priority(item_mask(rucksack.substr(0, half_len)) & item_mask(rucksack.substr(half_len)));
+        group &= item_mask(rucksack);
+        if (++in_group == group_size) {
+            scores.two += priority(group);
+            group = ~std::uint64_t{0};
+            in_group = 0;
+        }
+    }
+    return scores;
+}
+
+// Splits the inventory into one chunk per thread. Each thread first counts the lines in an equal
+// byte range; the prefix sums of those counts then let every chunk boundary be moved forward to the
+// next line starting a group of group_size rucksacks.
+Scores score_inventory(std::string_view text, unsigned int group_size, unsigned int n_threads) {
+    n_threads = std::max(1U, n_threads);
+    const auto run = [n_threads](auto&& task) {
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < n_threads; ++t) {
+            workers.emplace_back(task, t);
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    };
+
+    std::vector<std::size_t> lines_before(n_threads + 1, 0);
+    run([&](unsigned int t) {
+        const auto range = text.substr(text.size() * t / n_threads, text.size() * (t + 1) / n_threads - text.size() * t / n_threads);
+        lines_before[t + 1] = static_cast<std::size_t>(std::count(range.begin(), range.end(), '\n'));
+    });
+    std::partial_sum(lines_before.begin(), lines_before.end(), lines_before.begin());
+
+    const auto next_line = [text](std::size_t pos) {
+        const std::size_t newline = text.find('\n', pos);
+        return newline == std::string_view::npos ? text.size() : newline + 1;
+    };
+    std::vector<std::size_t> bounds(n_threads + 1, text.size());
+    bounds[0] = 0;
+    for (unsigned int t = 1; t < n_threads; ++t) {
+        // Line lines_before[t] starts after the first newline at or after the raw boundary.
+        std::size_t pos = text.size() * t / n_threads;
+        std::size_t line = lines_before[t];
+        if (pos > 0 && text[pos - 1] != '\n') {
+            pos = next_line(pos);
+            ++line;
+        }
+        for (; line % group_size != 0 && pos < text.size(); ++line) {
+            pos = next_line(pos);
+        }
+        bounds[t] = std::max(pos, bounds[t - 1]);
+    }
+
+    std::vector<Scores> partial(n_threads);
+    run([&](unsigned int t) {
+        partial[t] = score_lines(text.substr(bounds[t], bounds[t + 1] - bounds[t]), group_size);
+    });
+    Scores total;
+    for (const auto& scores : partial) {
+        total.one += scores.one;
+        total.two += scores.two;
+    }
+    return total;
+}
+
+// Read-only memory mapping of a whole file.
+class Mapped_File {
+public:
+    explicit Mapped_File(const char* path) {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st {};
+        if (::fstat(fd, &st) == 0) {
+            if (st.st_size > 0) {
+                void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED) {
+                    m_data = static_cast<const char*>(data);
+                    m_size = static_cast<std::size_t>(st.st_size);
+                }
+            }
+            m_ok = st.st_size == 0 || m_data;
+        }
+        ::close(fd);
+    }
+    Mapped_File(const Mapped_File&) = delete;
+    Mapped_File& operator=(const Mapped_File&) = delete;
+    ~Mapped_File() {
+        if (m_data) {
+            ::munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    explicit operator bool() const { return m_ok; }
+    std::string_view view() const { return {m_data, m_size}; }
+
+private:
+    const char* m_data = nullptr;
+    std::size_t m_size = 0;
+    bool m_ok = false;
+};
 
 int main() {
     for (auto file : {"sample.txt", "input.txt"}) {
-        std::ifstream input {file};
+        const Mapped_File input {file};
         if (!input) {
             std::cerr << "Failed to open: " << file << '\n';
             return 1;
         }
-        const auto score_item = [](char item) -> int {
-            return item >= 'a' ? item - 'a' + 1 : item - 'A' + 27;
-        };
-        int score_one = 0;
-        int score_two = 0;
-        int line_num  = 0;
-        std::map<char, int> counter;
-        std::string line;
-        while (std::getline(input, line)) {
-            for (char x : std::set<char>{line.begin(), line.end()}) {
-                ++counter[x];
-            }
-            unsigned int half_len = line.length() / 2;
-            std::set<char> fst {line.begin(), line.begin() + half_len};
-            char item = *std::find_if(line.begin() + half_len, line.end(), [&fst](char item) -> bool {
-                return fst.count(item);
-            });
-            score_one += score_item(item);
-
-            ++line_num;
-            if (line_num % 3 == 0) {
-                char badge = std::max_element(counter.begin(), counter.end(), [](const auto& a, const auto& b) -> bool {
-                    return a.second < b.second;
-                })->first;
-                score_two += score_item(badge);
-                counter.clear();
-            }
-        }
+        const auto scores = score_inventory(input.view(), group_size, std::thread::hardware_concurrency());
         std::cout << file << ":\n";
-        std::cout << "Answer part 1:  " << score_one << '\n';
-        std::cout << "Answer part 2:  " << score_two << '\n';
+        std::cout << "Answer part 1:  " << scores.one << '\n';
+        std::cout << "Answer part 2:  " << scores.two << '\n';
     }
     return 0;
 }
@@ -1,24 +1,119 @@
+#include <algorithm>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <iterator>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <vector>
 
-bool is_fully_overlapping(const std::pair<int, int>& range_a, const std::pair<int, int>& range_b) {
+using Range = std::pair<int, int>;
+
+bool is_fully_overlapping(const Range& range_a, const Range& range_b) {
     const auto& [a, b] = range_a;
     const auto& [c, d] = range_b;
     return (a >= c && b <= d) || (c >= a && d <= b);
 }
 
-bool is_overlapping(const std::pair<int, int>& range_a, const std::pair<int, int>& range_b) {
+bool is_overlapping(const Range& range_a, const Range& range_b) {
     const auto& [a, b] = range_a;
     const auto& [c, d] = range_b;
     return a <= d && b >= c;
 }
 
+// Static index over many section ranges for bulk overlap queries. Sorted starts and ends answer
+// overlap counts with two binary searches. Containment is a dominance count (start <= a, end >= b),
+// answered by a merge sort tree over the ranges ordered by start that keeps each node's ends sorted.
+class Interval_Index {
+public:
+    explicit Interval_Index(std::vector<Range> ranges);
+
+    std::size_t count_overlapping(const Range& range) const;
+    std::size_t count_containing(const Range& range) const;
+    unsigned long long overlapping_pairs() const;
+
+private:
+    std::vector<int> m_starts;
+    std::vector<int> m_ends;
+    std::size_t m_leaves = 1;
+    std::vector<std::vector<int>> m_tree;  // node i covers ranges ordered by start, holding their ends sorted
+};
+
+Interval_Index::Interval_Index(std::vector<Range> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    for (const auto& [start, end] : ranges) {
+        m_starts.push_back(start);
+        m_ends.push_back(end);
+    }
+    while (m_leaves < ranges.size()) {
+        m_leaves *= 2;
+    }
+    m_tree.resize(2 * m_leaves);
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        m_tree[m_leaves + i] = {ranges[i].second};
+    }
+    for (std::size_t i = m_leaves - 1; i > 0; --i) {
+        const auto& l = m_tree[2 * i];
+        const auto& r = m_tree[2 * i + 1];
+        std::merge(l.begin(), l.end(), r.begin(), r.end(), std::back_inserter(m_tree[i]));
+    }
+    std::sort(m_ends.begin(), m_ends.end());
+}
+
+std::size_t Interval_Index::count_overlapping(const Range& range) const {
+    const auto& [a, b] = range;
+    // A range misses [a, b] if it starts after b or ends before a, never both.
+    const auto starts_after = m_starts.end() - std::upper_bound(m_starts.begin(), m_starts.end(), b);
+    const auto ends_before = std::lower_bound(m_ends.begin(), m_ends.end(), a) - m_ends.begin();
+    return m_starts.size() - static_cast<std::size_t>(starts_after + ends_before);
+}
+
+std::size_t Interval_Index::count_containing(const Range& range) const {
+    const auto& [a, b] = range;
+    const auto prefix = static_cast<std::size_t>(std::upper_bound(m_starts.begin(), m_starts.end(), a) - m_starts.begin());
+    const auto ends_at_least = [b](const std::vector<int>& ends) {
+        return static_cast<std::size_t>(ends.end() - std::lower_bound(ends.begin(), ends.end(), b));
+    };
+    std::size_t count = 0;
+    for (std::size_t l = m_leaves, r = m_leaves + prefix; l < r; l /= 2, r /= 2) {
+        if (l & 1) count += ends_at_least(m_tree[l++]);
+        if (r & 1) count += ends_at_least(m_tree[--r]);
+    }
+    return count;
+}
+
+/* Number of unordered pairs of ranges that overlap. Of two disjoint ranges exactly one lies left of
+   the other, so each disjoint pair is counted once by looking up the ranges starting after each end. */
+unsigned long long Interval_Index::overlapping_pairs() const {
+    const unsigned long long n = m_starts.size();
+    unsigned long long disjoint = 0;
+    for (int end : m_ends) {
+        disjoint += static_cast<unsigned long long>(m_starts.end() - std::upper_bound(m_starts.begin(), m_starts.end(), end));
+    }
+    return n * (n - 1) / 2 - disjoint;
+}
+
+/* Parses "a-b,c-d" by scanning the four digit runs, skipping the separators between them. */
+std::optional<std::pair<Range, Range>> parse_assignment(std::string_view line) {
+    int nums[4];
+    std::size_t i = 0;
+    for (int& num : nums) {
+        while (i < line.size() && (line[i] < '0' || line[i] > '9')) {
+            ++i;
+        }
+        if (i == line.size()) {
+            return std::nullopt;
+        }
+        num = 0;
+        for (; i < line.size() && '0' <= line[i] && line[i] <= '9'; ++i) {
+            num = num * 10 + (line[i] - '0');
+        }
+    }
+    return std::make_pair(Range{nums[0], nums[1]}, Range{nums[2], nums[3]});
+}
+
 int main() {
-    std::regex re {"(\\d+)-(\\d+),(\\d+)-(\\d+)"};
-    std::smatch sm;
     for (auto file : {"sample.txt", "input.txt"}) {
         std::ifstream input {file};
         if (!input) {
@@ -27,17 +122,32 @@ int main() {
         }
         int ans_one = 0;
         int ans_two = 0;
+        std::vector<Range> all_ranges;
         std::string line;
         while (std::getline(input, line)) {
-            std::regex_match(line, sm, re);
-            auto range_a = std::make_pair(std::stoi(sm[1]), std::stoi(sm[2]));
-            auto range_b = std::make_pair(std::stoi(sm[3]), std::stoi(sm[4]));
+            const auto ranges = parse_assignment(line);
+            if (!ranges) {
+                continue;
+            }
+            const auto& [range_a, range_b] = *ranges;
             ans_one += is_fully_overlapping(range_a, range_b);
             ans_two += is_overlapping(range_a, range_b);
+            all_ranges.push_back(range_a);
+            all_ranges.push_back(range_b);
         }
         std::cout << file << ":\n";
         std::cout << "Answer part 1:  " << ans_one << '\n';
         std::cout << "Answer part 2:  " << ans_two << '\n';
+        if (all_ranges.empty()) {
+            continue;
+        }
+        const Range query = all_ranges.front();
+        const Interval_Index index {all_ranges};
+        std::cout << "Overlapping pairs of all assignments:  " << index.overlapping_pairs() << '\n';
+        std::cout << "Assignments overlapping " << query.first << '-' << query.second << ":  "
+                  << index.count_overlapping(query) << '\n';
+        std::cout << "Assignments containing " << query.first << '-' << query.second << ":  "
+                  << index.count_containing(query) << '\n';
     }
     return 0;
 }
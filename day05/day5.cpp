@@ -1,34 +1,248 @@
 #include <algorithm>
 #include <cctype>
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <iterator>
-#include <sstream>
+#include <random>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 using Stacks = std::vector<std::vector<char>>;
 using Moves  = std::vector<std::tuple<int, int, int>>;
 
-std::string top_string(const Stacks& stacks) {
+// Crate stacks as implicit treaps, one per stack, over a shared node pool, with crates in bottom to top
+// order. Moving n crates splits the top n off the source and merges them onto the target, both in
+// O(log n) expected time regardless of n. The CrateMover 9000 reverses the moved pile by toggling a
+// lazy flag on its root instead of touching the crates.
+class Crate_Stacks {
+public:
+    explicit Crate_Stacks(const Stacks& stacks);
+
+    void move(int n, int from, int to, bool keep_order);
+    std::string top_string() const;
+
+private:
+    static constexpr int nil = -1;
+
+    struct Node {
+        int left = nil, right = nil;
+        int size = 1;
+        std::uint32_t priority;
+        char crate;
+        bool reversed = false;
+    };
+
+    int size(int t) const { return t == nil ? 0 : m_nodes[t].size; }
+    void push_down(int t);
+    void update(int t);
+    std::pair<int, int> split(int t, int k);
+    int merge(int a, int b);
+
+    std::vector<Node> m_nodes;
+    std::vector<int> m_roots;
+};
+
+Crate_Stacks::Crate_Stacks(const Stacks& stacks) : m_roots(stacks.size(), nil) {
+    std::mt19937 rng {2022};
+    for (std::size_t i = 0; i < stacks.size(); ++i) {
+        for (char crate : stacks[i]) {
+            Node node;
+            node.priority = static_cast<std::uint32_t>(rng());
+            node.crate = crate;
+            m_nodes.push_back(node);
+            m_roots[i] = merge(m_roots[i], static_cast<int>(m_nodes.size()) - 1);
+        }
+    }
+}
+
+void Crate_Stacks::push_down(int t) {
+    Node& node = m_nodes[t];
+    if (!node.reversed) {
+        return;
+    }
+    std::swap(node.left, node.right);
+    for (int child : {node.left, node.right}) {
+        if (child != nil) {
+            m_nodes[child].reversed = !m_nodes[child].reversed;
+        }
+    }
+    node.reversed = false;
+}
+
+void Crate_Stacks::update(int t) {
+    m_nodes[t].size = 1 + size(m_nodes[t].left) + size(m_nodes[t].right);
+}
+
+/* Splits t into its first k crates and the rest. */
+std::pair<int, int> Crate_Stacks::split(int t, int k) {
+    if (t == nil) {
+        return {nil, nil};
+    }
+    push_down(t);
+    if (size(m_nodes[t].left) >= k) {
+        const auto [l, r] = split(m_nodes[t].left, k);
+        m_nodes[t].left = r;
+        update(t);
+        return {l, t};
+    }
+    const auto [l, r] = split(m_nodes[t].right, k - size(m_nodes[t].left) - 1);
+    m_nodes[t].right = l;
+    update(t);
+    return {t, r};
+}
+
+int Crate_Stacks::merge(int a, int b) {
+    if (a == nil || b == nil) {
+        return a == nil ? b : a;
+    }
+    if (m_nodes[a].priority > m_nodes[b].priority) {
+        push_down(a);
+        m_nodes[a].right = merge(m_nodes[a].right, b);
+        update(a);
+        return a;
+    }
+    push_down(b);
+    m_nodes[b].left = merge(a, m_nodes[b].left);
+    update(b);
+    return b;
+}
+
+void Crate_Stacks::move(int n, int from, int to, bool keep_order) {
+    const auto [rest, pile] = split(m_roots[from], std::max(0, size(m_roots[from]) - n));
+    m_roots[from] = rest;
+    if (!keep_order && pile != nil) {
+        m_nodes[pile].reversed = !m_nodes[pile].reversed;
+    }
+    m_roots[to] = merge(m_roots[to], pile);
+}
+
+std::string Crate_Stacks::top_string() const {
     std::string ret;
-    std::transform(stacks.cbegin(), stacks.cend(), std::back_inserter(ret), [](const auto& stk) -> char {
-        return stk.empty() ? ' ' : stk.back();
+    std::transform(m_roots.cbegin(), m_roots.cend(), std::back_inserter(ret), [this](int t) -> char {
+        if (t == nil) {
+            return ' ';
+        }
+        // Follow the last crate down, applying pending reversals along the path without modifying.
+        bool reversed = false;
+        for (;;) {
+            const Node& node = m_nodes[t];
+            reversed ^= node.reversed;
+            const int next = reversed ? node.left : node.right;
+            if (next == nil) {
+                return node.crate;
+            }
+            t = next;
+        }
     });
     return ret;
 }
 
-std::string solve(Stacks stacks, const Moves& moves, bool crate_mover_9001 = false) {
+std::string solve(const Stacks& stacks, const Moves& moves, bool crate_mover_9001 = false) {
+    Crate_Stacks engine {stacks};
+    for (const auto& [n, a, b] : moves) {
+        engine.move(n, a, b, crate_mover_9001);
+    }
+    return engine.top_string();
+}
+
+// Finds the top crates without moving any crates: each final top position is traced back through the
+// moves in reverse, as (stack, depth from the top), until it names a crate in the initial stacks.
+std::string solve_backward(const Stacks& stacks, const Moves& moves, bool crate_mover_9001 = false) {
+    std::vector<long long> sizes;
+    for (const auto& stk : stacks) {
+        sizes.push_back(static_cast<long long>(stk.size()));
+    }
     for (const auto& [n, a, b] : moves) {
-        if (crate_mover_9001)
-            std::move(stacks[a].end() - n, stacks[a].end(), std::back_inserter(stacks[b]));
-        else
-            std::move(stacks[a].rbegin(), stacks[a].rbegin() + n, std::back_inserter(stacks[b]));
-        stacks[a].erase(stacks[a].end() - n, stacks[a].end());
+        sizes[a] -= n;
+        sizes[b] += n;
+    }
+    std::string ret;
+    for (std::size_t s = 0; s < stacks.size(); ++s) {
+        if (sizes[s] == 0) {
+            ret.push_back(' ');
+            continue;
+        }
+        int stack = static_cast<int>(s);
+        long long depth = 0;
+        for (auto it = moves.rbegin(); it != moves.rend(); ++it) {
+            const auto& [n, a, b] = *it;
+            if (stack == a) {
+                depth += n;
+            } else if (stack == b) {
+                if (depth < n) {
+                    stack = a;
+                    depth = crate_mover_9001 ? depth : n - 1 - depth;
+                } else {
+                    depth -= n;
+                }
+            }
+        }
+        const auto& initial = stacks[stack];
+        ret.push_back(initial[initial.size() - 1 - depth]);
+    }
+    return ret;
+}
+
+// Parses "move n from a to b" lines by scanning for the three numbers on each line.
+Moves parse_moves(std::string_view text) {
+    Moves moves;
+    int nums[3] = {0, 0, 0};
+    int count = 0;
+    bool in_number = false;
+    for (char c : text) {
+        if ('0' <= c && c <= '9') {
+            if (!in_number && count < 3) {
+                nums[count++] = 0;
+            }
+            in_number = true;
+            nums[count - 1] = nums[count - 1] * 10 + (c - '0');
+        } else {
+            in_number = false;
+            if (c == '\n') {
+                if (count == 3) {
+                    moves.emplace_back(nums[0], nums[1] - 1, nums[2] - 1);
+                }
+                count = 0;
+            }
+        }
+    }
+    if (count == 3) {
+        moves.emplace_back(nums[0], nums[1] - 1, nums[2] - 1);
+    }
+    return moves;
+}
+
+// Splits the move list into line-aligned chunks parsed on separate threads.
+Moves parse_moves(std::string_view text, unsigned int n_threads) {
+    std::vector<std::string_view> chunks;
+    for (unsigned int t = std::max(1U, n_threads); t > 1 && !text.empty(); --t) {
+        const std::size_t newline = text.find('\n', text.size() / t);
+        const std::size_t cut = newline == std::string_view::npos ? text.size() : newline + 1;
+        chunks.push_back(text.substr(0, cut));
+        text.remove_prefix(cut);
+    }
+    if (!text.empty()) {
+        chunks.push_back(text);
+    }
+    std::vector<Moves> parts(chunks.size());
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < chunks.size(); ++i) {
+        workers.emplace_back([&parts, &chunks, i] { parts[i] = parse_moves(chunks[i]); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    Moves moves;
+    for (auto& part : parts) {
+        moves.insert(moves.end(), part.begin(), part.end());
     }
-    return top_string(stacks);
+    return moves;
 }
 
 int main() {
@@ -54,17 +268,17 @@ int main() {
         for (auto& stk : stacks) {
             std::reverse(stk.begin(), stk.end());
         }
-        Moves moves;
-        while (std::getline(input, line)) {
-            std::istringstream iss {line};
-            std::string redundant;
-            int n, a, b;
-            iss >> redundant >> n >> redundant >> a >> redundant >> b;
-            moves.emplace_back(n, a - 1, b - 1);
+        const std::string procedure {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        const Moves moves = parse_moves(procedure, std::thread::hardware_concurrency());
+        // Forward simulation costs about one tree node per crate, tracing back moves x stacks steps.
+        std::size_t num_crates = 0;
+        for (const auto& stk : stacks) {
+            num_crates += stk.size();
         }
+        const auto solver = moves.size() * stacks.size() < num_crates ? solve_backward : solve;
         std::cout << file << ":\n";
-        std::cout << "Answer part 1:  " << solve(stacks, moves, false) << '\n';
-        std::cout << "Answer part 2:  " << solve(stacks, moves, true) << '\n';
+        std::cout << "Answer part 1:  " << solver(stacks, moves, false) << '\n';
+        std::cout << "Answer part 2:  " << solver(stacks, moves, true) << '\n';
     }
     return 0;
 }
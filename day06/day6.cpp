@@ -1,23 +1,162 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <fstream>
 #include <iostream>
-#include <set>
 #include <string>
 #include <string_view>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 constexpr unsigned int packet_marker_length = 4;
 constexpr unsigned int message_marker_length = 14;
 
+// Sliding window over the last len bytes with a count per byte value and the number of byte values
+// occurring more than once, so each pushed byte is checked in O(1).
+class Marker_Detector {
+public:
+    explicit Marker_Detector(unsigned int len) : m_window(len) {}
+
+    // Returns true if the window ending with c holds len distinct bytes.
+    bool push(char c) {
+        const std::size_t len = m_window.size();
+        auto& slot = m_window[m_pos % len];
+        if (m_pos >= len && --m_counts[slot] == 1) {
+            --m_duplicates;
+        }
+        slot = static_cast<unsigned char>(c);
+        if (++m_counts[slot] == 2) {
+            ++m_duplicates;
+        }
+        ++m_pos;
+        return m_pos >= len && m_duplicates == 0;
+    }
+
+    std::size_t position() const { return m_pos; }
+
+private:
+    std::vector<unsigned char> m_window;
+    std::array<unsigned int, 256> m_counts {};
+    unsigned int m_duplicates = 0;
+    std::size_t m_pos = 0;
+};
+
 int find_marker(const std::string_view& signal, unsigned int len) {
-    for (unsigned int i = 0; i < signal.length() - len + 1; ++i) {
-        auto window  = signal.substr(i, len);
-        auto uniques = std::set<int> {window.begin(), window.end()};
-        if (uniques.size() == len) {
-            return i + len;
+    Marker_Detector detector {len};
+    for (char c : signal) {
+        if (detector.push(c)) {
+            return static_cast<int>(detector.position());
+        }
+    }
+    return -1;
+}
+
+// Last occurrence of c in [first, last), or nullptr, comparing 32 or 16 bytes at a time where available.
+const char* find_last_byte(const char* first, const char* last, char c) {
+#if defined(__AVX2__)
+    const __m256i needle = _mm256_set1_epi8(c);
+    for (; last - first >= 32; last -= 32) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last - 32));
+        if (const auto mask = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, needle)))) {
+            return last - 32 + (31 - __builtin_clz(mask));
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle_128 = _mm_set1_epi8(c);
+    for (; last - first >= 16; last -= 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last - 16));
+        if (const auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, needle_128)))) {
+            return last - 16 + (31 - __builtin_clz(mask));
+        }
+    }
+#endif
+    while (last != first) {
+        if (*--last == c) {
+            return last;
+        }
+    }
+    return nullptr;
+}
+
+// Same result as find_marker. If a byte in the window repeats an earlier byte at position p, no window
+// starting at or before p can be a marker, so the search skips to the last such p + 1. The part of the
+// window that survives a skip is known to be distinct, so only the bytes newly entering the window are
+// searched for, each only back to the current skip target.
+int find_marker_skip(const std::string_view& signal, unsigned int len) {
+    const char* data = signal.data();
+    std::size_t start = 0;
+    std::size_t checked = 0;  // [start, checked) holds distinct bytes
+    while (start + len <= signal.size()) {
+        const std::size_t end = start + len;
+        std::size_t next = start;
+        for (std::size_t q = end; q-- > std::max(checked, start) && next < q; ) {
+            if (const char* p = find_last_byte(data + next, data + q, data[q])) {
+                next = static_cast<std::size_t>(p - data) + 1;
+            }
+        }
+        if (next == start) {
+            return static_cast<int>(end);
         }
+        checked = end;
+        start = next;
     }
     return -1;
 }
 
+/* Positions just after every window of len distinct characters. */
+std::vector<std::size_t> find_markers(const std::string_view& signal, unsigned int len) {
+    std::vector<std::size_t> markers;
+    Marker_Detector detector {len};
+    for (char c : signal) {
+        if (detector.push(c)) {
+            markers.push_back(detector.position());
+        }
+    }
+    return markers;
+}
+
+// Reads the signal line from is in fixed-size blocks and runs one detector per marker length over it
+// in a single pass. on_marker(which, pos) is called with the index of the length and the marker
+// position as soon as it is found; once it returns false that length is done, and reading stops when
+// every length is done. Only each detector's window of the last len bytes is kept across blocks.
+template<typename F>
+void stream_markers(std::istream& is, const std::vector<unsigned int>& lens, F on_marker) {
+    constexpr std::size_t block_size = 1 << 12;
+    std::array<char, block_size> block;
+    std::vector<Marker_Detector> detectors(lens.begin(), lens.end());
+    std::vector<bool> done(lens.size(), false);
+    std::size_t remaining = lens.size();
+    while (is && remaining > 0) {
+        is.read(block.data(), block_size);
+        const auto n = static_cast<std::size_t>(is.gcount());
+        for (std::size_t i = 0; i < n && remaining > 0; ++i) {
+            if (block[i] == '\n') {
+                return;
+            }
+            for (std::size_t d = 0; d < detectors.size(); ++d) {
+                if (!done[d] && detectors[d].push(block[i]) && !on_marker(d, detectors[d].position())) {
+                    done[d] = true;
+                    --remaining;
+                }
+            }
+        }
+    }
+}
+
+/* First marker for each length, -1 where there is none. */
+std::vector<int> first_markers(std::istream& is, const std::vector<unsigned int>& lens) {
+    std::vector<int> markers(lens.size(), -1);
+    stream_markers(is, lens, [&markers](std::size_t which, std::size_t pos) {
+        markers[which] = static_cast<int>(pos);
+        return false;
+    });
+    return markers;
+}
+
 int main() {
     for (auto file : {"sample.txt", "input.txt"}) {
         std::ifstream input {file};
@@ -25,11 +164,10 @@ int main() {
             std::cerr << "Failed to open: " << file << '\n';
             return 1;
         }
-        std::string signal;
-        std::getline(input, signal);
+        const auto markers = first_markers(input, {packet_marker_length, message_marker_length});
         std::cout << file << ":\n";
-        std::cout << "Answer part 1:  " << find_marker(signal, packet_marker_length) << '\n';
-        std::cout << "Answer part 2:  " << find_marker(signal, message_marker_length) << '\n';
+        std::cout << "Answer part 1:  " << markers[0] << '\n';
+        std::cout << "Answer part 2:  " << markers[1] << '\n';
     }
     return 0;
 }
@@ -1,10 +1,14 @@
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <limits>
-#include <memory>
-#include <sstream>
+#include <numeric>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -13,127 +17,182 @@ namespace {
     constexpr std::size_t needed_space  = 30000000U;
 }
 
-class Directory {
+// Directory tree stored as a flat arena of nodes. Names are interned, children are found through a
+// hash index on (parent, name), and every node is created after its parent, so directory sizes can
+// be accumulated in one reverse pass over the arena.
+class File_System {
 public:
+    using Node_Id = std::uint32_t;
+    static constexpr Node_Id root = 0;
     static constexpr inline std::size_t NA_SIZE = std::numeric_limits<std::size_t>::max();
 
-    Directory(const std::string& name, Directory* parent = nullptr)
-        : m_name(name)
-        , m_parent(parent)
-        {}
+    File_System() { m_nodes.push_back({root, intern("/"), 0}); }
+    // The intern table's keys view this object's own name storage, which a move carries along but a
+    // copy would not.
+    File_System(const File_System&) = delete;
+    File_System& operator=(const File_System&) = delete;
+    File_System(File_System&&) = default;
+    File_System& operator=(File_System&&) = default;
 
-    void set_size(std::size_t new_size);
-    void add_subdirectory(const std::string& name);
-    void add_subdirectory(std::unique_ptr<Directory> subdir_ptr);
+    Node_Id add_directory(Node_Id parent, std::string_view name);
+    Node_Id parent(Node_Id id) const { return m_nodes[id].parent; }
+    void add_file(Node_Id id, std::size_t size) { m_nodes[id].size += size; }
+    void accumulate_sizes();
 
-    std::string name() const { return m_name; }
-    std::size_t size() const { return m_size; }
-    Directory* parent() const { return m_parent; }
-
-    const std::vector<std::unique_ptr<Directory>>& subdirectories() const { return m_subdirs; }
-    std::vector<std::unique_ptr<Directory>>& subdirectories() { return m_subdirs; }
+    std::size_t num_directories() const { return m_nodes.size(); }
+    std::size_t size(Node_Id id) const { return m_nodes[id].size; }
 
 private:
-    std::string m_name;
-    std::size_t m_size = 0;
-    Directory* m_parent;
-    std::vector<std::unique_ptr<Directory>> m_subdirs;
+    struct Node {
+        Node_Id parent;
+        std::uint32_t name;
+        std::size_t size;
+    };
+
+    static std::uint64_t key(Node_Id parent, std::uint32_t name) {
+        return static_cast<std::uint64_t>(parent) << 32 | name;
+    }
+
+    std::uint32_t intern(std::string_view name);
+
+    std::deque<std::string> m_names;
+    std::unordered_map<std::string_view, std::uint32_t> m_name_ids;
+    std::unordered_map<std::uint64_t, Node_Id> m_children;
+    std::vector<Node> m_nodes;
 };
 
-void Directory::add_subdirectory(const std::string& name) {
-    m_subdirs.push_back(std::make_unique<Directory>(name, this));
+std::uint32_t File_System::intern(std::string_view name) {
+    if (const auto it = m_name_ids.find(name); it != m_name_ids.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<std::uint32_t>(m_names.size());
+    m_names.emplace_back(name);
+    m_name_ids.emplace(m_names.back(), id);
+    return id;
 }
 
-void Directory::add_subdirectory(std::unique_ptr<Directory> subdir_ptr) {
-    m_subdirs.push_back(std::move(subdir_ptr));
+File_System::Node_Id File_System::add_directory(Node_Id parent, std::string_view name) {
+    const auto name_id = intern(name);
+    const auto [it, inserted] = m_children.emplace(key(parent, name_id), static_cast<Node_Id>(m_nodes.size()));
+    if (inserted) {
+        m_nodes.push_back({parent, name_id, 0});
+    }
+    return it->second;
 }
 
-void Directory::set_size(std::size_t new_size) {
-    std::size_t old_size = m_size;
-    m_size = new_size;
-    Directory* ptr = m_parent;
-    while (ptr) {
-        ptr->m_size -= old_size;
-        ptr->m_size += new_size;
-        ptr = ptr->m_parent;
+void File_System::accumulate_sizes() {
+    for (std::size_t id = m_nodes.size() - 1; id > 0; --id) {
+        m_nodes[m_nodes[id].parent].size += m_nodes[id].size;
     }
 }
 
-std::size_t sum_if_below(const Directory* root, std::size_t limit) {
-    std::size_t sum = root->size() < limit ? root->size() : 0;
-    for (const auto& ptr : root->subdirectories()) {
-        sum += sum_if_below(ptr.get(), limit);
+// Directory sizes sorted once, with prefix sums, so that size queries over the same dump are
+// binary searches.
+class Size_Index {
+public:
+    explicit Size_Index(const File_System& fs);
+
+    std::size_t sum_if_below(std::size_t limit) const;
+    std::size_t least_larger(std::size_t n) const;
+    std::size_t root_size() const { return m_root_size; }
+
+private:
+    std::vector<std::size_t> m_sizes;
+    std::vector<std::size_t> m_prefix;  // m_prefix[i] = sum of the i smallest sizes
+    std::size_t m_root_size;
+};
+
+Size_Index::Size_Index(const File_System& fs) : m_root_size(fs.size(File_System::root)) {
+    m_sizes.reserve(fs.num_directories());
+    for (File_System::Node_Id id = 0; id < fs.num_directories(); ++id) {
+        m_sizes.push_back(fs.size(id));
     }
-    return sum;
+    std::sort(m_sizes.begin(), m_sizes.end());
+    m_prefix.resize(m_sizes.size() + 1, 0);
+    std::partial_sum(m_sizes.begin(), m_sizes.end(), m_prefix.begin() + 1);
 }
 
-/* smallest size of directory tree of root that is >= n */
-std::size_t least_larger(Directory* root, std::size_t n) {
-    if (root->size() < n) {
-        return Directory::NA_SIZE;
-    }
-    std::size_t ret = root->size();
-    for (const auto& ptr : root->subdirectories()) {
-        ret = std::min(least_larger(ptr.get(), n), ret);
-    }
-    return ret;
+std::size_t Size_Index::sum_if_below(std::size_t limit) const {
+    return m_prefix[std::lower_bound(m_sizes.begin(), m_sizes.end(), limit) - m_sizes.begin()];
 }
 
-std::size_t size_to_remove(Directory* root) {
-    std::size_t unused_space  = total_space - root->size();
+/* smallest size of a directory that is >= n */
+std::size_t Size_Index::least_larger(std::size_t n) const {
+    const auto it = std::lower_bound(m_sizes.begin(), m_sizes.end(), n);
+    return it == m_sizes.end() ? File_System::NA_SIZE : *it;
+}
+
+std::size_t size_to_remove(const Size_Index& sizes) {
+    std::size_t unused_space  = total_space - sizes.root_size();
     std::size_t space_to_free = needed_space - unused_space;
-    return least_larger(root, space_to_free);
+    return sizes.least_larger(space_to_free);
 }
 
-/* Assumes well-behaved imput */
-std::unique_ptr<Directory> parse_terminal_output(const std::string& filename) {
-    std::ifstream input {filename};
-    if (!input) {
-        std::cerr << "Failed to open: " << filename << '\n';
-        return nullptr;
+void parse_line(File_System& fs, File_System::Node_Id& curr, std::string_view line) {
+    if (line.substr(0, 5) == "$ cd ") {
+        const auto target = line.substr(5);
+        if (target == "/") {
+            curr = File_System::root;
+        } else if (target == "..") {
+            curr = fs.parent(curr);
+        } else {
+            curr = fs.add_directory(curr, target);
+        }
+    } else if (line.substr(0, 4) == "dir ") {
+        fs.add_directory(curr, line.substr(4));
+    } else if (!line.empty() && line.front() != '$') {  // File begining with size
+        std::size_t size = 0;
+        if (std::from_chars(line.data(), line.data() + line.size(), size).ec == std::errc{}) {
+            fs.add_file(curr, size);
+        }
     }
-    auto root = std::make_unique<Directory>("/");
-    auto curr = root.get();
-    std::string line;
-    std::getline(input, line);  // Skip first line
-    while (std::getline(input, line)) {
-        std::istringstream iss {line};
-        std::string word;
-        iss >> word;
-        if (word == "$") {
-            iss >> word;
-            if (word == "ls") {
-                continue;
-            }
-            iss >> word;
-            if (word == "..") {
-                curr = curr->parent();
-            } else {
-                curr = std::find_if(curr->subdirectories().cbegin(),
-                                    curr->subdirectories().cend(),
-                                    [&word](const auto& ptr) -> bool {
-                                        return ptr->name() == word;
-                                    })->get();
+}
+
+/* Assumes well-behaved imput. Reads the log in large blocks and parses the lines in place. */
+File_System parse_terminal_output(std::istream& is) {
+    constexpr std::size_t block_size = 1 << 16;
+    File_System fs;
+    auto curr = File_System::root;
+    std::string buffer;
+    std::size_t carry = 0;
+    while (is) {
+        buffer.resize(carry + block_size);
+        is.read(buffer.data() + carry, block_size);
+        const std::size_t end = carry + static_cast<std::size_t>(is.gcount());
+        std::size_t begin = 0;
+        for (std::size_t i = carry; i < end; ++i) {
+            if (buffer[i] == '\n') {
+                parse_line(fs, curr, std::string_view{buffer.data() + begin, i - begin});
+                begin = i + 1;
             }
-        } else if (word == "dir") {
-            iss >> word;
-            curr->add_subdirectory(word);
-        } else {  // File begining with size
-            curr->set_size(curr->size() + std::stoul(word));
         }
+        carry = end - begin;
+        std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
     }
-    return root;
+    parse_line(fs, curr, std::string_view{buffer.data(), carry});
+    fs.accumulate_sizes();
+    return fs;
 }
 
-int main() {
-    for (auto filename : {"sample.txt", "input.txt"}) {
-        std::unique_ptr<Directory> root = parse_terminal_output(filename);
-        if (!root) {
-            return 1;
+/* Reads the logs named on the command line, "-" meaning stdin, or the sample and input by default. */
+int main(int argc, char* argv[]) {
+    std::vector<std::string> filenames(argv + 1, argv + argc);
+    if (filenames.empty()) {
+        filenames = {"sample.txt", "input.txt"};
+    }
+    for (const auto& filename : filenames) {
+        std::ifstream file;
+        if (filename != "-") {
+            file.open(filename);
+            if (!file) {
+                std::cerr << "Failed to open: " << filename << '\n';
+                return 1;
+            }
         }
+        const Size_Index sizes {parse_terminal_output(filename == "-" ? std::cin : file)};
         std::cout << filename << ":\n";
-        std::cout << "Answer part 1:  " << sum_if_below(root.get(), size_limit) << '\n';
-        std::cout << "Answer part 2:  " << size_to_remove(root.get()) << '\n';
+        std::cout << "Answer part 1:  " << sizes.sum_if_below(size_limit) << '\n';
+        std::cout << "Answer part 2:  " << size_to_remove(sizes) << '\n';
     }
     return 0;
 }
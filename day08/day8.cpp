@@ -1,131 +1,124 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <stack>
 #include <string>
-#include <unordered_set>
+#include <thread>
 #include <utility>
 #include <vector>
 
-int part_one(const std::vector<std::string>& grid) {
-    int M = static_cast<int>(grid.size());
-    int N = static_cast<int>(grid.front().size());
-    int top = 0;
-    std::unordered_set<int> seen;
-
-    const auto flatten = [N](int row, int col) -> int {
-        return row * N + col;
-    };
-
-    const auto process = [&](int row, int col) -> void {
-        if (grid[row][col] > top) {
-            seen.insert(flatten(row, col));
-            top = grid[row][col];
-        }
-    };
-
-    for (int i = 0; i < M; ++i) {
-        seen.insert(flatten(i, 0));
-        top = grid[i][0];
-        for (int j = 1; j < N; ++j) {
-            process(i, j);
-        }
-        seen.insert(flatten(i, N - 1));
-        top = grid[i][N - 1];
-        for (int j = N - 2; j >= 0; --j) {
-            process(i, j);
+// Tree heights in one row-major buffer.
+struct Tree_Grid {
+    int M = 0, N = 0;
+    std::vector<std::uint8_t> heights;
+
+    explicit Tree_Grid(const std::vector<std::string>& lines)
+        : M(static_cast<int>(lines.size()))
+        , N(static_cast<int>(lines.front().size()))
+    {
+        heights.reserve(static_cast<std::size_t>(M) * N);
+        for (const auto& line : lines) {
+            heights.insert(heights.end(), line.begin(), line.end());
         }
     }
 
-    for (int j = 0; j < N; ++j) {
-        seen.insert(flatten(0, j));
-        top = grid[0][j];
-        for (int i = 1; i < M; ++i) {
-            process(i, j);
-        }
-        seen.insert(flatten(M - 1, j));
-        top = grid[M - 1][j];
-        for (int i = M - 2; i >= 0; --i) {
-            process(i, j);
+    const std::uint8_t* row(int i) const { return heights.data() + static_cast<std::size_t>(i) * N; }
+};
+
+// Keeps a running maximum per column while sweeping whole rows, so the vertical passes are
+// elementwise over contiguous rows and vectorize. Heights are ASCII digits, so 0 is below every tree.
+void sweep_columns(const Tree_Grid& grid, std::vector<std::uint8_t>& visible, int first, int last, int dir) {
+    const int N = grid.N;
+    std::vector<std::uint8_t> top(N, 0);
+    for (int i = first; i != last; i += dir) {
+        const std::uint8_t* h = grid.row(i);
+        std::uint8_t* v = visible.data() + static_cast<std::size_t>(i) * N;
+        for (int j = 0; j < N; ++j) {
+            v[j] |= h[j] > top[j];
+            top[j] = std::max(top[j], h[j]);
         }
     }
-
-    return static_cast<int>(seen.size());
 }
 
-int part_two(const std::vector<std::string>& grid) {
-    int M = static_cast<int>(grid.size());
-    int N = static_cast<int>(grid.front().size());
-
-    const auto evaluate = [&](const auto& coord) -> char {
-        const auto& [row, col] = coord;
-        return grid[row][col];
-    };
-
-    const auto pop_while_smaller = [&evaluate](char val, auto& stk) -> void {
-        while (!stk.empty() && evaluate(stk.top()) < val) {
-            stk.pop();
-        }
-    };
-
-    const auto length_down = [M, N](int row, auto& stk) -> int {
-        return stk.empty() ? row : row - stk.top().first;
-    };
-
-    const auto length_up = [M, N](int row, auto& stk) -> int {
-        return stk.empty() ? M - 1 - row : stk.top().first;
-    };
-
-    const auto length_left = [N](int col, auto& stk) -> int {
-        return stk.empty() ? col : col - stk.top().second;
-    };
+int part_one(const Tree_Grid& grid) {
+    const int M = grid.M, N = grid.N;
+    std::vector<std::uint8_t> visible(grid.heights.size(), 0);
 
-    const auto length_right = [N](int col, auto& stk) -> int {
-        return stk.empty() ? N - 1 - col : stk.top().second - col;
-    };
-
-    const auto first_not_smaller = [&](int row, int col, auto& stk, auto&& length_callback) -> int {
-        pop_while_smaller(grid[row][col], stk);
-        int ret = length_callback(stk);
-        stk.emplace(row, col);
-        return ret;
-    };
-
-    std::vector<std::vector<int>> scenic_table(M, std::vector<int>(N, 1));
-    
     for (int i = 0; i < M; ++i) {
-        std::stack<std::pair<int, int>> stk;
-        stk.emplace(i, 0);
-        for (int j = 1; j < N; ++j) {
-            scenic_table[i][j] *= first_not_smaller(i, j, stk, [&](auto& stk){ return length_left(j, stk); });
+        const std::uint8_t* h = grid.row(i);
+        std::uint8_t* v = visible.data() + static_cast<std::size_t>(i) * N;
+        std::uint8_t top = 0;
+        for (int j = 0; j < N && top < '9'; ++j) {
+            v[j] |= h[j] > top;
+            top = std::max(top, h[j]);
         }
-        stk = {};
-        stk.emplace(i, N - 1);
-        for (int j = N - 2; j >= 0; --j) {
-            scenic_table[i][j] *= first_not_smaller(i, j, stk, [&](auto& stk){ return length_right(j, stk); });
+        top = 0;
+        for (int j = N - 1; j >= 0 && top < '9'; --j) {
+            v[j] |= h[j] > top;
+            top = std::max(top, h[j]);
         }
     }
+    sweep_columns(grid, visible, 0, M, 1);
+    sweep_columns(grid, visible, M - 1, -1, -1);
 
-    for (int j = 0; j < N; ++j) {
-        std::stack<std::pair<int, int>> stk;
-        stk.emplace(0, j);
-        for (int i = 1; i < M; ++i) {
-            scenic_table[i][j] *= first_not_smaller(i, j, stk, [&](auto& stk){ return length_down(i, stk); });
-        }
-        stk = {};
-        stk.emplace(M - 1, j);
-        for (int i = M - 2; i >= 0; --i) {
-            scenic_table[i][j] *= first_not_smaller(i, j, stk, [&](auto& stk){ return length_up(i, stk); });
+    return static_cast<int>(std::count(visible.begin(), visible.end(), 1));
+}
+
+// Runs f(begin, end, stack) over [0, count) split into contiguous ranges, one per thread, each with
+// its own reusable index stack.
+template<typename F>
+void parallel_ranges(int count, unsigned int n_threads, F f) {
+    n_threads = std::clamp(n_threads, 1U, static_cast<unsigned int>(std::max(count, 1)));
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < n_threads; ++t) {
+        const int begin = static_cast<int>(static_cast<long long>(count) * t / n_threads);
+        const int end = static_cast<int>(static_cast<long long>(count) * (t + 1) / n_threads);
+        workers.emplace_back([&f, begin, end] {
+            std::vector<int> stack;
+            f(begin, end, stack);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Multiplies into scenic the viewing distance of each of the n trees at base, base + stride, ...
+// looking back towards base. The stack holds positions of trees not shorter than those after them.
+void view_distances(const Tree_Grid& grid, std::vector<int>& scenic, std::size_t base, std::ptrdiff_t stride,
+                    int n, std::vector<int>& stack) {
+    stack.clear();
+    for (int k = 0; k < n; ++k) {
+        const std::size_t idx = base + k * stride;
+        const std::uint8_t h = grid.heights[idx];
+        while (!stack.empty() && grid.heights[base + stack.back() * stride] < h) {
+            stack.pop_back();
         }
+        scenic[idx] *= stack.empty() ? k : k - stack.back();
+        stack.push_back(k);
     }
+}
 
-    int max_scenic = 0;
+int part_two(const Tree_Grid& grid, unsigned int n_threads = 1) {
+    const int M = grid.M, N = grid.N;
+    std::vector<int> scenic(grid.heights.size(), 1);
 
-    for (int i = 1; i + 1 < M; ++i) {
-        for (int j = 1; j + 1 < N; ++j) {
-            max_scenic = std::max(scenic_table[i][j], max_scenic);
+    parallel_ranges(M, n_threads, [&](int begin, int end, std::vector<int>& stack) {
+        for (int i = begin; i < end; ++i) {
+            const std::size_t first = static_cast<std::size_t>(i) * N;
+            view_distances(grid, scenic, first, 1, N, stack);
+            view_distances(grid, scenic, first + N - 1, -1, N, stack);
         }
-    }
-    return max_scenic;
+    });
+    parallel_ranges(N, n_threads, [&](int begin, int end, std::vector<int>& stack) {
+        for (int j = begin; j < end; ++j) {
+            view_distances(grid, scenic, j, N, M, stack);
+            view_distances(grid, scenic, static_cast<std::size_t>(M - 1) * N + j, -static_cast<std::ptrdiff_t>(N), M, stack);
+        }
+    });
+
+    return *std::max_element(scenic.begin(), scenic.end());
 }
 
 int main() {
@@ -141,8 +134,9 @@ int main() {
             grid.push_back(line);
         }
         std::cout << file << ":\n";
-        std::cout << "Answer part 1:  " << part_one(grid) << '\n';
-        std::cout << "Answer part 2:  " << part_two(grid) << '\n';
+        const Tree_Grid trees {grid};
+        std::cout << "Answer part 1:  " << part_one(trees) << '\n';
+        std::cout << "Answer part 2:  " << part_two(trees, std::thread::hardware_concurrency()) << '\n';
     }
     return 0;
 }
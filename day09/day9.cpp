@@ -1,17 +1,17 @@
-#include <array>
+#include <algorithm>
+#include <bitset>
 #include <cstddef>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
-#include <set>
-#include <map>
 #include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace {
-    constexpr unsigned int short_rope_length = 2U;
-    constexpr unsigned int long_rope_length = 10U;
+    constexpr std::size_t short_rope_length = 2U;
+    constexpr std::size_t long_rope_length = 10U;  // At least short_rope_length, both come from one run.
 }
 
 struct Point {
@@ -92,27 +92,129 @@ int sign(int x) {
     return (x > 0) - (x < 0);
 }
 
-template<unsigned int rope_length>
-std::size_t solve(const std::vector<std::pair<char, int>>& moves) {
-    std::array<Point, rope_length> rope;
-    std::set<Point> visited = {rope.front()};
-    static const std::map<char, Point> directions = {{'U', {-1, 0}}, {'R', {0, 1}},
-                                                     {'D', {1, 0}}, {'L', {0, -1}}};
+Point direction(char dir) {
+    switch (dir) {
+        case 'U': return {-1, 0};
+        case 'R': return {0, 1};
+        case 'D': return {1, 0};
+        case 'L': return {0, -1};
+    }
+    return {0, 0};
+}
+
+// Every knot stays inside the bounding box of the head's path, since it only ever steps towards
+// the knot in front of it.
+std::pair<Point, Point> head_bounds(const std::vector<std::pair<char, int>>& moves) {
+    Point head, lo, hi;
+    for (const auto& [dir, steps] : moves) {
+        head += steps * direction(dir);
+        lo = Point(std::min(lo.x, head.x), std::min(lo.y, head.y));
+        hi = Point(std::max(hi.x, head.x), std::max(hi.y, head.y));
+    }
+    return {lo, hi};
+}
+
+class Visited_Bitmap {
+public:
+    Visited_Bitmap(const Point& lo, const Point& hi)
+        : m_lo(lo)
+        , m_width(static_cast<std::size_t>(hi.y - lo.y + 1))
+        , m_words((static_cast<std::size_t>(hi.x - lo.x + 1) * m_width + 63) / 64, 0)
+        {}
+
+    void mark(const Point& p) {
+        const std::size_t i = index(p);
+        m_words[i / 64] |= std::uint64_t{1} << (i % 64);
+    }
+
+    // Marks from + step, from + 2 * step, ..., from + count * step. Runs along a row are set a word at a time.
+    void mark_run(const Point& from, const Point& step, int count) {
+        if (count <= 0) {
+            return;
+        }
+        if (step.x != 0) {
+            for (int t = 1; t <= count; ++t) {
+                mark(from + t * step);
+            }
+            return;
+        }
+        std::size_t first = index(from + step);
+        std::size_t last = index(from + count * step);
+        if (first > last) {
+            std::swap(first, last);
+        }
+        for (std::size_t i = first; i <= last; ) {
+            const std::size_t bit = i % 64;
+            const std::size_t n = std::min<std::size_t>(64 - bit, last - i + 1);
+            const std::uint64_t bits = n == 64 ? ~std::uint64_t{0} : ((std::uint64_t{1} << n) - 1) << bit;
+            m_words[i / 64] |= bits;
+            i += n;
+        }
+    }
+
+    std::size_t count() const {
+        std::size_t n = 0;
+        for (auto word : m_words) {
+            n += std::bitset<64>(word).count();
+        }
+        return n;
+    }
+
+private:
+    std::size_t index(const Point& p) const {
+        return static_cast<std::size_t>(p.x - m_lo.x) * m_width + (p.y - m_lo.y);
+    }
+
+    Point m_lo;
+    std::size_t m_width;
+    std::vector<std::uint64_t> m_words;
+};
+
+// Simulates a rope of rope_length knots once. Knot k moves the same way in every rope longer than k
+// knots, so the returned counts[k] is the number of cells visited by the tail of a rope of length k + 1.
+// A knot that does not move leaves every knot behind it in place, so propagation stops there. Once a whole
+// step has translated every knot by the head's move, the rope lies straight behind the head and the rest
+// of the move is applied to all knots at once.
+std::vector<std::size_t> solve(const std::vector<std::pair<char, int>>& moves, std::size_t rope_length) {
+    std::vector<Point> rope(rope_length);
+    const auto [lo, hi] = head_bounds(moves);
+    std::vector<Visited_Bitmap> visited(rope_length, Visited_Bitmap{lo, hi});
+    for (auto& bitmap : visited) {
+        bitmap.mark(Point{});
+    }
 
     for (const auto& [dir, steps] : moves) {
-        const auto move = directions.at(dir);
+        const auto move = direction(dir);
         for (int step = 0; step < steps; ++step) {
             rope.front() += move;
-            for (unsigned int i = 0; i + 1 < rope_length; ++i) {
+            visited.front().mark(rope.front());
+            bool translated = true;
+            std::size_t i = 0;
+            for (; i + 1 < rope_length; ++i) {
                 auto diff = rope[i] - rope[i + 1];
-                if (std::abs(diff.x) > 1 || std::abs(diff.y) > 1) {
-                    rope[i + 1] += Point(sign(diff.x), sign(diff.y));
+                if (std::abs(diff.x) <= 1 && std::abs(diff.y) <= 1) {
+                    break;
                 }
+                const Point delta(sign(diff.x), sign(diff.y));
+                translated = translated && delta == move;
+                rope[i + 1] += delta;
+                visited[i + 1].mark(rope[i + 1]);
+            }
+            if (translated && i + 1 == rope_length) {
+                const int remaining = steps - step - 1;
+                for (std::size_t k = 0; k < rope_length; ++k) {
+                    visited[k].mark_run(rope[k], move, remaining);
+                    rope[k] += remaining * move;
+                }
+                break;
             }
-            visited.insert(rope.back());
         }
     }
-    return visited.size();
+    std::vector<std::size_t> counts;
+    for (const auto& bitmap : visited) {
+        counts.push_back(bitmap.count());
+    }
+    return counts;
 }
 
 int main() {
@@ -131,9 +233,10 @@ int main() {
             iss >> direction >> steps;
             moves.emplace_back(direction, steps);
         }
+        const auto counts = solve(moves, long_rope_length);
         std::cout << file << ":\n";
-        std::cout << "Answer part 1:  " << solve<short_rope_length>(moves) << '\n';
-        std::cout << "Answer part 2:  " << solve<long_rope_length>(moves) << '\n';
+        std::cout << "Answer part 1:  " << counts[short_rope_length - 1] << '\n';
+        std::cout << "Answer part 2:  " << counts[long_rope_length - 1] << '\n';
     }
     return 0;
 }
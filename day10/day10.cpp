@@ -1,16 +1,157 @@
-#include <array>
+#include <algorithm>
+#include <charconv>
 #include <fstream>
+#include <iterator>
 #include <iostream>
-#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace {
+    using ull = unsigned long long;
     constexpr unsigned int screen_pixels = 240U;
     constexpr unsigned int screen_width  = 40U;
-    constexpr unsigned int max_cycles    = 300U;  // Some extra spare cycles.
 }
 
+enum class Opcode : char { noop, addx };
+
+struct Instruction {
+    Opcode op;
+    int arg;
+};
+
+using Program = std::vector<Instruction>;
+
+Program decode(std::istream& is) {
+    Program program;
+    std::string line;
+    while (std::getline(is, line)) {
+        std::string_view sv {line};
+        if (sv.substr(0, 4) == "noop") {
+            program.push_back({Opcode::noop, 0});
+        } else if (sv.substr(0, 4) == "addx") {
+            sv.remove_prefix(std::min(sv.size(), std::size_t{5}));
+            if (!sv.empty() && sv.front() == '+') {
+                sv.remove_prefix(1);
+            }
+            int x = 0;
+            std::from_chars(sv.data(), sv.data() + sv.size(), x);
+            program.push_back({Opcode::addx, x});
+        }
+    }
+    return program;
+}
+
+// Runs the program for at most max_cycles cycles and passes the register value during every cycle
+// (cycles counted from 1) to each sink. Returns the number of cycles executed.
+template<typename... Sinks>
+ull run(const Program& program, ull max_cycles, Sinks&... sinks) {
+    ull cycle = 0;
+    int x = 1;
+    const auto tick = [&]() -> bool {
+        if (cycle == max_cycles) {
+            return false;
+        }
+        ++cycle;
+        (sinks(cycle, x), ...);
+        return true;
+    };
+    for (const auto& [op, arg] : program) {
+        switch (op) {
+            case Opcode::noop:
+                if (!tick()) return cycle;
+                break;
+            case Opcode::addx:
+                if (!tick() || !tick()) return cycle;
+                x += arg;
+                break;
+        }
+    }
+    return cycle;
+}
+
+// Register value as runs of (first cycle, value), one run per value change, so memory grows with the
+// number of addx instructions rather than with the number of cycles.
+class Register_Timeline {
+public:
+    explicit Register_Timeline(const Program&);
+
+    ull cycles() const { return m_cycles; }
+    int value_at(ull cycle) const;
+    std::vector<int> values_at(const std::vector<ull>& sorted_cycles) const;
+    long long signal_strength(ull first, ull step) const;
+
+private:
+    struct Run {
+        ull start;
+        int value;
+    };
+    std::vector<Run> m_runs;
+    ull m_cycles = 0;
+};
+
+Register_Timeline::Register_Timeline(const Program& program) : m_runs{{1, 1}} {
+    int x = 1;
+    for (const auto& [op, arg] : program) {
+        m_cycles += op == Opcode::addx ? 2 : 1;
+        if (op == Opcode::addx && arg != 0) {
+            x += arg;
+            m_runs.push_back({m_cycles + 1, x});
+        }
+    }
+}
+
+/* Cycles before the first one read as the initial value. */
+int Register_Timeline::value_at(ull cycle) const {
+    const auto it = std::upper_bound(m_runs.begin(), m_runs.end(), cycle,
+                                     [](ull c, const Run& run) { return c < run.start; });
+    return it == m_runs.begin() ? it->value : std::prev(it)->value;
+}
+
+// Evaluates a sorted sampling schedule, each search starting from the run of the previous sample.
+std::vector<int> Register_Timeline::values_at(const std::vector<ull>& sorted_cycles) const {
+    std::vector<int> values;
+    values.reserve(sorted_cycles.size());
+    auto it = m_runs.begin();
+    for (ull cycle : sorted_cycles) {
+        it = std::upper_bound(it, m_runs.end(), cycle, [](ull c, const Run& run) { return c < run.start; });
+        if (it == m_runs.begin()) {
+            values.push_back(it->value);
+            continue;
+        }
+        values.push_back(std::prev(it)->value);
+        --it;
+    }
+    return values;
+}
+
+long long Register_Timeline::signal_strength(ull first, ull step) const {
+    if (step == 0) {
+        throw std::invalid_argument("signal_strength: step must be positive");
+    }
+    std::vector<ull> schedule;
+    for (ull cycle = first; cycle <= m_cycles; cycle += step) {
+        schedule.push_back(cycle);
+    }
+    const auto values = values_at(schedule);
+    long long sum = 0;
+    for (std::size_t i = 0; i < schedule.size(); ++i) {
+        sum += static_cast<long long>(schedule[i]) * values[i];
+    }
+    return sum;
+}
+
+struct Crt {
+    std::string screen = std::string(screen_pixels, '.');
+
+    void operator()(ull cycle, int x) {
+        const ull pixel = (cycle - 1) % screen_pixels;
+        const int pos = static_cast<int>(pixel % screen_width);
+        screen[pixel] = x - 1 <= pos && pos <= x + 1 ? '#' : '.';
+    }
+};
+
 int main() {
     for (auto file : {"sample.txt", "input.txt"}) {
         std::ifstream input {file};
@@ -18,46 +159,15 @@ int main() {
             std::cerr << "Failed to open: " << file << '\n';
             return 1;
         }
-        std::string line;
-        unsigned int cycle = 0;                  // Let 0 be the first cycle due zero based indexing.
-        std::array<int, max_cycles> regs = {1};  // regs[i] = register value at cycle i.
-        std::string screen(max_cycles, '.');
-
-        const auto draw = [&regs, &screen](int cycle) -> void {
-            int pos = cycle % screen_width;
-            if (regs[cycle] - 1 <= pos && pos <= regs[cycle] + 1) {
-                screen[cycle] = '#';
-            }
-        };
-
-        while (std::getline(input, line)) {
-            draw(cycle);
-            ++cycle;
-            regs[cycle] = regs[cycle - 1];
-            std::istringstream iss {line};
-            std::string inst;
-            iss >> inst;
-            if (inst == "noop") {
-                continue;
-            } else if (inst == "addx") {
-                int x;
-                iss >> x;
-                draw(cycle);
-                ++cycle;
-                regs[cycle] = regs[cycle - 1] + x;
-            }
-            if (cycle >= screen_pixels) {
-                break;
-            }
-        }
-        int signal_strength_sum = 0;
-        for (unsigned int i = 20; i < screen_pixels; i += 40) {
-            signal_strength_sum += i * regs[i - 1];
-        }
+        const Program program = decode(input);
+        const Register_Timeline timeline {program};
+        Crt crt;
+        run(program, screen_pixels, crt);
+
         std::cout << file << "\n";
-        std::cout << "Signal strenght sum: " << signal_strength_sum << '\n';
+        std::cout << "Signal strenght sum: " << timeline.signal_strength(20, screen_width) << '\n';
         std::cout << "Screen:\n";
-        std::string_view screen_view {screen};
+        std::string_view screen_view {crt.screen};
         for (unsigned int i = 0; i < screen_pixels; i += screen_width) {
             std::cout << screen_view.substr(i, screen_width) << '\n';
         }
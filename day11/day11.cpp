@@ -1,11 +1,16 @@
 #include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <optional>
 #include <queue>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -15,13 +20,64 @@ namespace {
     constexpr unsigned int num_rounds_two = 10000U;
 }
 
+enum class Opcode : char { add, sub, mul, div };
+
+// A monkey lowered from its description: "new = lhs op rhs", where an empty operand means "old",
+// followed by a throw to if_true or if_false depending on divisibility by divisor.
 template<typename T>
 struct Monkey {
     std::queue<T> items;
-    std::function<T(T)> worry_update;
-    std::function<int(T)> throw_to;
+    Opcode op = Opcode::add;
+    std::optional<T> lhs, rhs;
+    T divisor = 1;
+    int if_true = 0;
+    int if_false = 0;
 };
 
+template<typename T>
+T worry_update(const Monkey<T>& monkey, T old) {
+    const T x = monkey.lhs.value_or(old);
+    const T y = monkey.rhs.value_or(old);
+    switch (monkey.op) {
+        case Opcode::add: return x + y;
+        case Opcode::sub: return x - y;
+        case Opcode::mul: return x * y;
+        case Opcode::div: return x / y;
+    }
+    return 0;
+}
+
+template<typename T>
+int throw_to(const Monkey<T>& monkey, T item) {
+    return item % monkey.divisor == 0 ? monkey.if_true : monkey.if_false;
+}
+
+template<typename T, typename Op>
+void apply_each(const Monkey<T>& monkey, T* first, T* last, Op op) {
+    if (monkey.lhs && monkey.rhs) {
+        std::fill(first, last, op(*monkey.lhs, *monkey.rhs));
+    } else if (monkey.lhs) {
+        const T x = *monkey.lhs;
+        std::transform(first, last, first, [x, op](T old) { return op(x, old); });
+    } else if (monkey.rhs) {
+        const T y = *monkey.rhs;
+        std::transform(first, last, first, [y, op](T old) { return op(old, y); });
+    } else {
+        std::transform(first, last, first, [op](T old) { return op(old, old); });
+    }
+}
+
+// Applies the monkey's operation to a whole batch of items, with the dispatch hoisted out of the loop.
+template<typename T>
+void worry_update(const Monkey<T>& monkey, T* first, T* last) {
+    switch (monkey.op) {
+        case Opcode::add: apply_each(monkey, first, last, std::plus<T>{});       break;
+        case Opcode::sub: apply_each(monkey, first, last, std::minus<T>{});      break;
+        case Opcode::mul: apply_each(monkey, first, last, std::multiplies<T>{}); break;
+        case Opcode::div: apply_each(monkey, first, last, std::divides<T>{});    break;
+    }
+}
+
 template<typename T>
 T gcd(T a, T b) {
     return b == 0 ? a : gcd<T>(b, a % b);
@@ -32,22 +88,113 @@ T lcm(T a, T b) {
     return a / gcd<T>(a, b) * b;
 }
 
-template<typename T>
-ull monkey_business(unsigned int num_rounds, std::vector<Monkey<T>> monkeys, const std::function<T(T)>& worry_capper) {
-    std::vector<ull> inspects(monkeys.size(), 0);
+ull top_two_product(std::vector<ull> inspects) {
+    std::partial_sort(inspects.begin(), inspects.begin() + 2, inspects.end(), std::greater<ull>{});
+    return inspects[0] * inspects[1];
+}
+
+// Items live in one preallocated buffer with a fixed-capacity slot range per monkey, sized for the total
+// number of items. A monkey empties its whole range on its turn and never throws to itself, so every
+// range stays contiguous from its start and can be updated in one batch.
+template<typename T, typename Capper>
+ull monkey_business(unsigned int num_rounds, const std::vector<Monkey<T>>& monkeys, Capper worry_capper) {
+    const std::size_t n = monkeys.size();
+    std::size_t capacity = 0;
+    for (const auto& monkey : monkeys) {
+        capacity += monkey.items.size();
+    }
+    std::vector<T> items(n * capacity);
+    std::vector<std::size_t> sizes(n, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        for (auto queue = monkeys[i].items; !queue.empty(); queue.pop()) {
+            items[i * capacity + sizes[i]++] = queue.front();
+        }
+    }
+
+    std::vector<ull> inspects(n, 0);
     for (unsigned int round = 0; round < num_rounds; ++round) {
-        for (unsigned int i = 0; i < monkeys.size(); ++i) {
-            Monkey<T>& monkey = monkeys[i];
-            inspects[i] += monkey.items.size();
-            while (!monkey.items.empty()) {
-                T item = worry_capper(monkey.worry_update(monkey.items.front()));
-                monkey.items.pop();
-                monkeys[monkey.throw_to(item)].items.push(item);
+        for (std::size_t i = 0; i < n; ++i) {
+            const Monkey<T>& monkey = monkeys[i];
+            T* first = items.data() + i * capacity;
+            T* last = first + sizes[i];
+            inspects[i] += sizes[i];
+            worry_update(monkey, first, last);
+            std::transform(first, last, first, worry_capper);
+            for (T* item = first; item != last; ++item) {
+                const int j = throw_to(monkey, *item);
+                items[j * capacity + sizes[j]++] = *item;
             }
+            sizes[i] = 0;
         }
     }
-    std::sort(inspects.begin(), inspects.end(), std::greater<ull>{});
-    return inspects[0] * inspects[1];
+    return top_two_product(std::move(inspects));
+}
+
+// Inspection counts per monkey when worry levels are kept modulo mod. Every item moves independently,
+// and its state (worry level, holder) at the start of a round eventually repeats, so each item is
+// traced until its first repeated state and the counts for the remaining rounds are extrapolated from
+// the cycle. Items are distributed over n_threads threads. Only valid for + and * operations.
+template<typename T>
+std::vector<ull> item_inspections(ull num_rounds, const std::vector<Monkey<T>>& monkeys, T mod, unsigned int n_threads) {
+    const std::size_t n = monkeys.size();
+    std::vector<std::pair<T, int>> items;
+    for (std::size_t i = 0; i < n; ++i) {
+        for (auto queue = monkeys[i].items; !queue.empty(); queue.pop()) {
+            items.emplace_back(queue.front() % mod, static_cast<int>(i));
+        }
+    }
+
+    const auto trace = [&monkeys, n, num_rounds, mod](T value, int holder, std::vector<ull>& inspects) {
+        std::unordered_map<ull, ull> first_seen;  // state -> round
+        std::vector<ull> counts(n, 0);
+        std::vector<ull> prefix(counts);          // counts after each round, flattened
+        for (ull round = 0; round < num_rounds; ++round) {
+            const auto [it, inserted] = first_seen.emplace(static_cast<ull>(value) * n + holder, round);
+            if (!inserted) {
+                const ull start = it->second;
+                const ull cycle_len = round - start;
+                const ull q = (num_rounds - start) / cycle_len;
+                const ull r = (num_rounds - start) % cycle_len;
+                for (std::size_t m = 0; m < n; ++m) {
+                    const ull base = prefix[start * n + m];
+                    inspects[m] += base + q * (prefix[round * n + m] - base) + (prefix[(start + r) * n + m] - base);
+                }
+                return;
+            }
+            // Thrown items are inspected again in the same round if the receiver has not had its turn yet.
+            for (bool same_round = true; same_round; ) {
+                ++counts[holder];
+                value = worry_update(monkeys[holder], value) % mod;
+                const int next = throw_to(monkeys[holder], value);
+                same_round = next > holder;
+                holder = next;
+            }
+            prefix.insert(prefix.end(), counts.begin(), counts.end());
+        }
+        for (std::size_t m = 0; m < n; ++m) {
+            inspects[m] += counts[m];
+        }
+    };
+
+    n_threads = std::max(1U, n_threads);
+    std::vector<std::vector<ull>> partial(n_threads, std::vector<ull>(n, 0));
+    std::atomic<std::size_t> next_item {0};
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < n_threads; ++t) {
+        workers.emplace_back([&, t] {
+            for (std::size_t i; (i = next_item++) < items.size(); ) {
+                trace(items[i].first, items[i].second, partial[t]);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::vector<ull> inspects(n, 0);
+    for (const auto& p : partial) {
+        std::transform(p.begin(), p.end(), inspects.begin(), inspects.begin(), std::plus<ull>{});
+    }
+    return inspects;
 }
 
 int main() {
@@ -78,17 +225,15 @@ int main() {
                 std::string l, r;
                 char op;
                 iss >> word >> word >> l >> op >> r;  // new = l op r
-                monkeys.back().worry_update = [l, op, r](ull old) -> ull {
-                    ull x = l == "old" ? old : std::stoull(l);
-                    ull y = r == "old" ? old : std::stoull(r);
-                    switch (op) {
-                        case '+': return x + y;
-                        case '-': return x - y;
-                        case '*': return x * y;
-                        case '/': return x / y;
-                    }
-                    return 0;
-                };
+                auto& monkey = monkeys.back();
+                monkey.lhs = l == "old" ? std::nullopt : std::optional<ull>{std::stoull(l)};
+                monkey.rhs = r == "old" ? std::nullopt : std::optional<ull>{std::stoull(r)};
+                switch (op) {
+                    case '+': monkey.op = Opcode::add; break;
+                    case '-': monkey.op = Opcode::sub; break;
+                    case '*': monkey.op = Opcode::mul; break;
+                    case '/': monkey.op = Opcode::div; break;
+                }
             } else if (word == "Test:") {
                 ull divby = std::stoull(std::string(line.begin() + line.find_first_of(digits), line.end()));
 
@@ -99,13 +244,13 @@ int main() {
                 int idx_false = std::stoi(std::string(line.begin() + line.find_first_of(digits), line.end()));
 
                 mod = lcm<ull>(mod, divby);
-                monkeys.back().throw_to = [divby, idx_true, idx_false](ull item) -> int {
-                    return item % divby == 0 ? idx_true : idx_false;
-                };
+                monkeys.back().divisor = divby;
+                monkeys.back().if_true = idx_true;
+                monkeys.back().if_false = idx_false;
             }
         }
         ull ans_one = monkey_business<ull>(num_rounds_one, monkeys,    [](ull item) -> ull { return item / 3;   });
-        ull ans_two = monkey_business<ull>(num_rounds_two, monkeys, [mod](ull item) -> ull { return item % mod; });
+        ull ans_two = top_two_product(item_inspections<ull>(num_rounds_two, monkeys, mod, std::thread::hardware_concurrency()));
         std::cout << file << ":\n";
         std::cout << "Answer part 1:  " << ans_one << '\n';
         std::cout << "Answer part 2:  " << ans_two << '\n';
@@ -1,13 +1,19 @@
 #include <algorithm>
 #include <array>
+#include <bitset>
+#include <charconv>
+#include <cstdint>
+#include <climits>
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <optional>
 #include <queue>
-#include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 struct Point {
@@ -48,10 +54,129 @@ std::tuple_element_t<I, Point>& get(const Point& p) {
     if constexpr (I == 2) return p.z;
 }
 
+// Sparse voxel set stored as 16x16x16 bit chunks keyed by the full chunk coordinate, so any int
+// coordinate is supported. The bounding box is kept up to date on every insert so that no second pass
+// over the voxels is needed to size a dense grid.
+class Voxel_Store {
+public:
+    static constexpr int chunk_bits = 4;
+    static constexpr int chunk_side = 1 << chunk_bits;
+    using Chunk = std::bitset<chunk_side * chunk_side * chunk_side>;
+
+    void insert(const Point&);
+    bool contains(const Point&) const;
+
+    bool empty() const { return m_size == 0; }
+    std::size_t size() const { return m_size; }
+    const Point& lower() const { return m_lower; }
+    const Point& upper() const { return m_upper; }
+
+    template<typename F>
+    void for_each(F&& f) const;
+
+private:
+    struct Chunk_Hash {
+        std::size_t operator()(const Point& c) const {
+            std::uint64_t h = static_cast<std::uint32_t>(c.x);
+            h = h * 0x9E3779B97F4A7C15ULL ^ static_cast<std::uint32_t>(c.y);
+            h = h * 0x9E3779B97F4A7C15ULL ^ static_cast<std::uint32_t>(c.z);
+            return static_cast<std::size_t>(h ^ (h >> 29));
+        }
+    };
+
+    static Point chunk_key(const Point&);
+    static std::size_t chunk_offset(const Point&);
+
+    std::unordered_map<Point, Chunk, Chunk_Hash> m_chunks;
+    std::size_t m_size = 0;
+    Point m_lower {INT_MAX, INT_MAX, INT_MAX};
+    Point m_upper {INT_MIN, INT_MIN, INT_MIN};
+};
+
+Point Voxel_Store::chunk_key(const Point& p) {
+    return Point{p.x >> chunk_bits, p.y >> chunk_bits, p.z >> chunk_bits};
+}
+
+std::size_t Voxel_Store::chunk_offset(const Point& p) {
+    constexpr int mask = chunk_side - 1;
+    return ((p.x & mask) << (2 * chunk_bits)) | ((p.y & mask) << chunk_bits) | (p.z & mask);
+}
+
+void Voxel_Store::insert(const Point& p) {
+    auto bit = m_chunks[chunk_key(p)][chunk_offset(p)];
+    if (bit) {
+        return;
+    }
+    bit = true;
+    ++m_size;
+    m_lower = Point{std::min(m_lower.x, p.x), std::min(m_lower.y, p.y), std::min(m_lower.z, p.z)};
+    m_upper = Point{std::max(m_upper.x, p.x), std::max(m_upper.y, p.y), std::max(m_upper.z, p.z)};
+}
+
+bool Voxel_Store::contains(const Point& p) const {
+    const auto it = m_chunks.find(chunk_key(p));
+    return it != m_chunks.end() && it->second[chunk_offset(p)];
+}
+
+template<typename F>
+void Voxel_Store::for_each(F&& f) const {
+    for (const auto& [key, chunk] : m_chunks) {
+        const int cx = key.x * chunk_side;
+        const int cy = key.y * chunk_side;
+        const int cz = key.z * chunk_side;
+        for (std::size_t i = 0; i < chunk.size(); ++i) {
+            if (chunk[i]) {
+                f(Point{cx + static_cast<int>(i >> (2 * chunk_bits)),
+                        cy + static_cast<int>((i >> chunk_bits) & (chunk_side - 1)),
+                        cz + static_cast<int>(i & (chunk_side - 1))});
+            }
+        }
+    }
+}
+
+// Reads "x,y,z" lines in large blocks and parses them in place with std::from_chars.
+Voxel_Store parse_voxels(std::istream& is) {
+    constexpr std::size_t block_size = 1 << 16;
+    Voxel_Store store;
+    std::string buffer;
+    std::size_t carry = 0;
+    const auto parse_line = [&store](const char* first, const char* last) {
+        int coords[3];
+        for (int& c : coords) {
+            const auto [ptr, ec] = std::from_chars(first, last, c);
+            if (ec != std::errc{}) {
+                return;
+            }
+            first = ptr == last ? ptr : ptr + 1;
+        }
+        store.insert(Point{coords[0], coords[1], coords[2]});
+    };
+    while (is) {
+        buffer.resize(carry + block_size);
+        is.read(buffer.data() + carry, block_size);
+        const std::size_t end = carry + static_cast<std::size_t>(is.gcount());
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < end; ++i) {
+            if (buffer[i] == '\n') {
+                parse_line(buffer.data() + begin, buffer.data() + i);
+                begin = i + 1;
+            }
+        }
+        carry = end - begin;
+        std::copy(buffer.begin() + begin, buffer.begin() + end, buffer.begin());
+    }
+    parse_line(buffer.data(), buffer.data() + carry);
+    return store;
+}
+
 class Grid_3D {
 public:
     using Grid = std::vector<std::vector<std::vector<int>>>;
 
+    explicit Grid_3D(const Voxel_Store& store)
+        : Grid_3D(to_grid(store))
+        {}
+
     Grid_3D(const Grid& grid)
         : m_grid(grid)
         , m_dim(std::make_tuple(static_cast<int>(grid.size()),
@@ -63,9 +188,12 @@ public:
     bool occupied(const Point&) const;
 
     unsigned int exterior_surface_area();
+    unsigned int exterior_surface_area_flood_fill(unsigned int n_threads = 1);
     unsigned int surface_area();
 
 private:
+    static Grid to_grid(const Voxel_Store&);
+
     static const inline std::array<Point, 6> cardinal_directions {{Point{0, 0, 1}, Point{0, 0, -1},
                                                                    Point{0, 1, 0}, Point{0, -1, 0},
                                                                    Point{1, 0, 0}, Point{-1, 0, 0}}};
@@ -74,6 +202,16 @@ private:
     std::optional<unsigned int> m_surface_area;
 };
 
+Grid_3D::Grid Grid_3D::to_grid(const Voxel_Store& store) {
+    const auto& lo = store.lower();
+    const auto& hi = store.upper();
+    auto grid = std::vector(hi.x - lo.x + 1, std::vector(hi.y - lo.y + 1, std::vector(hi.z - lo.z + 1, 0)));
+    store.for_each([&grid, &lo](const Point& p) {
+        grid[p.x - lo.x][p.y - lo.y][p.z - lo.z] = 1;
+    });
+    return grid;
+}
+
 bool Grid_3D::on_grid(const Point& p) const {
     const auto& [M, N, K] = m_dim;
     return 0 <= p.x && p.x < M && 0 <= p.y && p.y < N && 0 <= p.z && p.z < K;
@@ -118,7 +256,7 @@ unsigned int Grid_3D::exterior_surface_area() {
         todo.push(start);
         bool is_exterior = false;
         while (!todo.empty()) {
-            auto&& [x, y, z] = todo.front();
+            const auto [x, y, z] = todo.front();
             todo.pop();
             if (processed[x][y][z]) {
                 continue;
@@ -152,6 +290,90 @@ unsigned int Grid_3D::exterior_surface_area() {
     return surface_area() - interior_area;
 }
 
+// Flood fills the air around the droplet once, inside a bounding box padded by one voxel so that the exterior
+// is connected, and counts the lava faces touched by exterior air. The fill extends runs along z and seeds the
+// neighbouring x/y rows at the start of each new run, and the face count is split over z-slabs across threads.
+unsigned int Grid_3D::exterior_surface_area_flood_fill(unsigned int n_threads) {
+    enum Cell : char { air, lava, exterior };
+    const auto& [M, N, K] = m_dim;
+    const int PM = M + 2, PN = N + 2, PK = K + 2;
+    const auto index = [PN, PK](int x, int y, int z) {
+        return (static_cast<std::size_t>(x) * PN + y) * PK + z;
+    };
+    std::vector<char> cells(static_cast<std::size_t>(PM) * PN * PK, air);
+    for (int x = 0; x < M; ++x) {
+        for (int y = 0; y < N; ++y) {
+            for (int z = 0; z < K; ++z) {
+                if (m_grid[x][y][z]) {
+                    cells[index(x + 1, y + 1, z + 1)] = lava;
+                }
+            }
+        }
+    }
+
+    std::vector<Point> seeds {Point{0, 0, 0}};
+    while (!seeds.empty()) {
+        const auto [x, y, z] = seeds.back();
+        seeds.pop_back();
+        if (cells[index(x, y, z)] != air) {
+            continue;
+        }
+        int lo = z, hi = z;
+        while (lo > 0 && cells[index(x, y, lo - 1)] == air) {
+            --lo;
+        }
+        while (hi + 1 < PK && cells[index(x, y, hi + 1)] == air) {
+            ++hi;
+        }
+        std::fill(cells.begin() + index(x, y, lo), cells.begin() + index(x, y, hi) + 1, exterior);
+        for (const auto& [nx, ny] : {std::pair{x - 1, y}, std::pair{x + 1, y}, std::pair{x, y - 1}, std::pair{x, y + 1}}) {
+            if (nx < 0 || nx >= PM || ny < 0 || ny >= PN) {
+                continue;
+            }
+            bool in_run = false;
+            for (int nz = lo; nz <= hi; ++nz) {
+                const bool open = cells[index(nx, ny, nz)] == air;
+                if (open && !in_run) {
+                    seeds.emplace_back(nx, ny, nz);
+                }
+                in_run = open;
+            }
+        }
+    }
+
+    const auto count_slab = [&](int z_begin, int z_end) {
+        unsigned int area = 0;
+        for (int x = 1; x <= M; ++x) {
+            for (int y = 1; y <= N; ++y) {
+                for (int z = z_begin; z < z_end; ++z) {
+                    if (cells[index(x, y, z)] != lava) {
+                        continue;
+                    }
+                    for (const auto& [dx, dy, dz] : cardinal_directions) {
+                        if (cells[index(x + dx, y + dy, z + dz)] == exterior) {
+                            ++area;
+                        }
+                    }
+                }
+            }
+        }
+        return area;
+    };
+
+    n_threads = std::clamp(n_threads, 1U, static_cast<unsigned int>(K));
+    std::vector<unsigned int> partial(n_threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < n_threads; ++t) {
+        const int z_begin = 1 + static_cast<int>(t * K / n_threads);
+        const int z_end = 1 + static_cast<int>((t + 1) * K / n_threads);
+        workers.emplace_back([&, t, z_begin, z_end] { partial[t] = count_slab(z_begin, z_end); });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return std::accumulate(partial.begin(), partial.end(), 0U);
+}
+
 int main() {
     for (auto file : {"sample.txt", "input.txt"}) {
         std::ifstream input {file};
@@ -159,30 +381,15 @@ int main() {
             std::cerr << "Failed to open: " << file << '\n';
             return 1;
         }
-        std::string line;
-        std::vector<int> xs, ys, zs;
-        while (std::getline(input, line)) {
-            std::replace(line.begin(), line.end(), ',', ' ');
-            std::istringstream iss {line};
-            int x, y, z;
-            iss >> x >> y >> z;
-            xs.push_back(x);
-            ys.push_back(y);
-            zs.push_back(z);
-        }
-        const auto& [x_min, x_max] = std::minmax_element(xs.begin(), xs.end());
-        const auto& [y_min, y_max] = std::minmax_element(ys.begin(), ys.end());
-        const auto& [z_min, z_max] = std::minmax_element(zs.begin(), zs.end());
-
-        auto grid = std::vector(*x_max - *x_min + 1, std::vector(*y_max - *y_min + 1, std::vector(*z_max - *z_min + 1, 0)));
-        for (std::size_t i = 0; i < xs.size(); ++i) {
-            grid[xs[i] - *x_min][ys[i] - *y_min][zs[i] - *z_min] = 1;
+        const auto store = parse_voxels(input);
+        if (store.empty()) {
+            std::cerr << "No voxels in: " << file << '\n';
+            return 1;
         }
-
-        Grid_3D g_3D {grid};
+        Grid_3D g_3D {store};
         std::cout << file << ":\n";
         std::cout << "Answer part 1:  " << g_3D.surface_area() << '\n';
-        std::cout << "Answer part 2:  " << g_3D.exterior_surface_area() << '\n';
+        std::cout << "Answer part 2:  " << g_3D.exterior_surface_area_flood_fill(std::thread::hardware_concurrency()) << '\n';
     }
     return 0;
 }